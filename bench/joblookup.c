@@ -0,0 +1,194 @@
+/*
+ * joblookup - Compare job table lookups and memory use for the old
+ *    job_t layout (command line embedded in every record) and the
+ *    current hot/cold split with command lines interned in an arena.
+ *
+ *    The tables here hold njobs entries rather than tsh's MAXJOBS, so
+ *    the difference shows up at a size where it matters. Each layout
+ *    is filled the way addjob fills it, then timed on an fgpid-style
+ *    scan (the FG job is last, so every entry is visited) and on
+ *    getjobpid-style lookups of random PIDs. RSS is the growth in
+ *    resident pages while the layout is allocated and filled.
+ *
+ * Usage: cc -O2 -o joblookup bench/joblookup.c && ./joblookup [njobs]
+ *    default: 10000 jobs
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+
+#define MAXLINE    1024   /* same as tsh.c */
+#define FG 1
+#define BG 2
+#define SCANS       200   /* fgpid scans to time */
+#define LOOKUPS   20000   /* getjobpid lookups to time */
+
+struct oldjob_t {           /* job_t before the split */
+    pid_t pid;
+    int jid;
+    int state;
+    char cmdline[MAXLINE];
+};
+
+struct job_t {              /* hot half, as in tsh.c */
+    pid_t pid;
+    int jid;
+    int state;
+};
+
+struct jobinfo_t {          /* cold half, as in tsh.c */
+    int cmdoff;
+    int cmdlen;
+    int outfd;
+    long long deadline;
+    int heapidx;
+    int termsent;
+};
+
+volatile long sink;         /* keeps the compiler from dropping the scans */
+
+/* now - Return CLOCK_MONOTONIC in ns */
+long long now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* rsskb - Return this process's resident set size in KB */
+long rsskb(void)
+{
+    long size, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp != NULL) {
+        if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose(fp);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* mkcmdline - A command line of typical length for job i */
+void mkcmdline(char *buf, int i)
+{
+    sprintf(buf, "/bin/sh -c 'sleep %d; echo job %d done' &\n", i % 97, i);
+}
+
+/* report - Print one layout's results */
+void report(const char *name, long kb, long long scan_ns, long long lookup_ns)
+{
+    printf("%-10s  rss %8ld KB  fgpid scan %9.1f us  getjobpid %7.1f ns\n",
+           name, kb, scan_ns / 1000.0 / SCANS, (double)lookup_ns / LOOKUPS);
+}
+
+int main(int argc, char **argv)
+{
+    int njobs = argc > 1 ? atoi(argv[1]) : 10000;
+    char cmd[MAXLINE];
+    pid_t *keys;
+    long before, kb;
+    long long t, scan_ns, lookup_ns;
+    int i, r, len, used;
+
+    if (njobs < 1) {
+        fprintf(stderr, "usage: %s [njobs]\n", argv[0]);
+        exit(1);
+    }
+    keys = malloc(LOOKUPS * sizeof(*keys));
+    srand(1);
+    for (i = 0; i < LOOKUPS; i++)
+        keys[i] = 1000 + rand() % njobs;
+    printf("%d jobs\n", njobs);
+
+    /* old layout */
+    {
+        struct oldjob_t *jobs;
+
+        before = rsskb();
+        jobs = malloc(njobs * sizeof(*jobs));
+        for (i = 0; i < njobs; i++) {
+            jobs[i].pid = 1000 + i;
+            jobs[i].jid = i + 1;
+            jobs[i].state = i == njobs - 1 ? FG : BG;
+            mkcmdline(cmd, i);
+            strcpy(jobs[i].cmdline, cmd);
+        }
+        kb = rsskb() - before;
+
+        t = now();
+        for (r = 0; r < SCANS; r++)
+            for (i = 0; i < njobs; i++)
+                if (jobs[i].state == FG) {
+                    sink += jobs[i].pid;
+                    break;
+                }
+        scan_ns = now() - t;
+        t = now();
+        for (r = 0; r < LOOKUPS; r++)
+            for (i = 0; i < njobs; i++)
+                if (jobs[i].pid == keys[r]) {
+                    sink += jobs[i].jid;
+                    break;
+                }
+        lookup_ns = now() - t;
+        report("embedded", kb, scan_ns, lookup_ns);
+        free(jobs);
+    }
+
+    /* hot/cold layout with an arena */
+    {
+        struct job_t *jobs;
+        struct jobinfo_t *jobinfo;
+        char *arena;
+
+        before = rsskb();
+        jobs = malloc(njobs * sizeof(*jobs));
+        jobinfo = malloc(njobs * sizeof(*jobinfo));
+        arena = malloc(njobs * 64); // enough for mkcmdline; tsh grows it as needed
+        for (i = 0, used = 0; i < njobs; i++) {
+            jobs[i].pid = 1000 + i;
+            jobs[i].jid = i + 1;
+            jobs[i].state = i == njobs - 1 ? FG : BG;
+            mkcmdline(cmd, i);
+            len = strlen(cmd);
+            memcpy(&arena[used], cmd, len + 1);
+            jobinfo[i].cmdoff = used;
+            jobinfo[i].cmdlen = len;
+            jobinfo[i].outfd = -1;
+            jobinfo[i].deadline = 0;
+            jobinfo[i].heapidx = -1;
+            jobinfo[i].termsent = 0;
+            used += len + 1;
+        }
+        kb = rsskb() - before;
+
+        t = now();
+        for (r = 0; r < SCANS; r++)
+            for (i = 0; i < njobs; i++)
+                if (jobs[i].state == FG) {
+                    sink += jobs[i].pid;
+                    break;
+                }
+        scan_ns = now() - t;
+        t = now();
+        for (r = 0; r < LOOKUPS; r++)
+            for (i = 0; i < njobs; i++)
+                if (jobs[i].pid == keys[r]) {
+                    sink += jobs[i].jid;
+                    break;
+                }
+        lookup_ns = now() - t;
+        report("hot/cold", kb, scan_ns, lookup_ns);
+        free(jobs);
+        free(jobinfo);
+        free(arena);
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# launch.sh - Measure tsh's command launch latency for several zygote
+#     pool sizes. tsh is built with -DLAUNCH_BENCH, which makes eval()
+#     print "P <ns>" just before it launches a command; the command is
+#     stamp, which prints "C <ns>" as soon as it runs. The latency is
+#     the difference, from eval() to the first instruction of the new
+#     program.
+#
+# Usage: bench/launch.sh [runs] [pool sizes...]
+#     defaults: 1000 runs, pool sizes 0 1 4 16
+#
+
+N=${1:-1000}
+[ $# -gt 0 ] && shift
+SIZES=${*:-"0 1 4 16"}
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cc -O2 -DLAUNCH_BENCH -o "$TMP/tsh" "$DIR/../tsh.c" || exit 1
+cc -O2 -static -o "$TMP/stamp" "$DIR/stamp.c" 2>/dev/null ||
+    cc -O2 -o "$TMP/stamp" "$DIR/stamp.c" || exit 1
+
+i=0
+while [ $i -lt "$N" ]; do
+    echo "$TMP/stamp"
+    i=$((i + 1))
+done > "$TMP/cmds"
+
+echo "$N foreground launches per pool size, latency in us"
+for z in $SIZES; do
+    "$TMP/tsh" -p -z "$z" < "$TMP/cmds" |
+        awk '$1 == "P" { p = $2 } $1 == "C" { printf "%.1f\n", ($2 - p) / 1000 }' |
+        sort -n > "$TMP/lat"
+    awk -v z="$z" '{ v[NR] = $1 }
+        END { printf "-z %-3d median %7.1f  p90 %7.1f  p99 %7.1f\n", z,
+              v[int(NR * 0.5) + 1], v[int(NR * 0.9) + 1], v[int(NR * 0.99) + 1] }' "$TMP/lat"
+done
@@ -0,0 +1,16 @@
+/*
+ * stamp - Print CLOCK_MONOTONIC in ns as "C <ns>" and exit.
+ *    Used by launch.sh as the command tsh launches. Link it statically
+ *    so dynamic loading doesn't count towards the launch latency.
+ */
+#include <stdio.h>
+#include <time.h>
+
+int main(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    printf("C %lld\n", ts.tv_sec * 1000000000LL + ts.tv_nsec);
+    return 0;
+}
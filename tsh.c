@@ -13,6 +13,11 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <time.h>
+#include <math.h>
 #include <errno.h>
 #include <fcntl.h>
 
@@ -21,6 +26,12 @@
 #define MAXARGS     128   /* max args on a command line */
 #define MAXJOBS      16   /* max jobs at any point in time */
 #define MAXJID    1<<16   /* max job ID */
+#define OUTBUF_JOB  (64*1024)  /* max captured output bytes per job */
+#define OUTBUF_MAX (256*1024)  /* max captured output bytes for all jobs */
+#define OUTCHUNK      4096     /* captured output is stored in chunks of this size */
+#define MAXZYGOTES   16   /* max pre-forked processes in the pool */
+#define KILLGRACE     2   /* seconds from a timed out job's SIGTERM to its SIGKILL */
+#define MAXTIMEOUT  1e9   /* longest timeout in seconds (~31 years), keeps deadlines in range */
 
 /* Job states */
 #define UNDEF 0 /* undefined */
@@ -44,14 +55,80 @@ char prompt[] = "tsh> ";    /* command line prompt (DO NOT CHANGE) */
 int verbose = 0;            /* if true, print additional output */
 int nextjid = 1;            /* next job ID to allocate */
 char sbuf[MAXLINE];         /* for composing sprintf messages */
+int capture = 0;            /* if true, capture background job output (-o) */
+int nzygotes = 0;           /* size of the pre-forked pool (-z), 0 if none */
+char inbuf[MAXLINE];        /* input read from fd 0 but not yet returned by readcmd */
+int inlen = 0;              /* bytes held in inbuf */
 
+/*
+ * The job list is split in two. struct job_t holds only the fields that
+ * fgpid, getjobpid and friends scan (the PID doubles as the process
+ * group ID), so a whole-table scan stays within a few cache lines.
+ * Everything else lives in struct jobinfo_t, indexed like jobs[].
+ */
 struct job_t {              /* The job struct */
     pid_t pid;              /* job PID */
     int jid;                /* job ID [1, 2, ...] */
     int state;              /* UNDEF, BG, FG, or ST */
-    char cmdline[MAXLINE];  /* command line */
 };
 struct job_t jobs[MAXJOBS]; /* The job list */
+
+struct jobinfo_t {          /* Per-job data off the lookup path */
+    int cmdoff;             /* offset of command line in cmdarena, -1 if none */
+    int cmdlen;             /* command line length, not counting the '\0' */
+    int outfd;              /* read end of output capture pipe, -1 if none */
+    long long deadline;     /* CLOCK_MONOTONIC ns of next timeout signal */
+    int heapidx;            /* position in dlheap, -1 if no deadline */
+    int termsent;           /* if true, the next timeout signal is SIGKILL */
+    int status;             /* waitpid status once reaped, for endcapture */
+};
+struct jobinfo_t jobinfo[MAXJOBS]; /* indexed like jobs[] */
+
+char *cmdarena = NULL;      /* command lines of jobs, back to back */
+int cmdarena_size = 0;      /* bytes allocated for cmdarena */
+int cmdarena_used = 0;      /* bytes handed out, including deleted jobs' */
+int cmdarena_live = 0;      /* bytes still owned by a job */
+
+int dlheap[MAXJOBS];        /* jobs[] indexes, min-heap on jobinfo deadline */
+int dlheap_len = 0;         /* number of jobs with a deadline */
+int timerfd = -1;           /* armed for the earliest deadline, -1 until first timeout */
+
+/*
+ * Captured output is kept in OUTCHUNK-sized chunks carved from a single
+ * pool of OUTBUF_MAX bytes. Chunks are handed out in order and recycled
+ * through outfree, so pages of the pool are only touched once they are
+ * needed and memory use never exceeds OUTBUF_MAX.
+ */
+struct outchunk_t {         /* A piece of captured output */
+    struct outchunk_t *next; /* next newer chunk of the same job */
+    int len;                /* bytes used in data */
+    char data[OUTCHUNK];
+};
+struct outchunk_t outpool[OUTBUF_MAX / OUTCHUNK]; /* all capture storage */
+int outpool_next = 0;       /* outpool entries from here on were never used */
+struct outchunk_t *outfree = NULL; /* chunks given back by outbuf_drop */
+
+struct outbuf_t {           /* Captured output of a background job */
+    struct outchunk_t *first; /* oldest chunk, NULL if empty */
+    struct outchunk_t *last;  /* newest chunk, NULL if empty */
+    int len;                /* number of bytes held */
+    unsigned long lastuse;  /* LRU stamp, bumped on append and view */
+    unsigned long dropped;  /* bytes evicted since the job started */
+    int jid;                /* job it came from, once the job is done */
+    pid_t pid;
+    int status;             /* and how it ended, as from waitpid */
+};
+struct outbuf_t outbufs[MAXJOBS]; /* indexed like jobs[] */
+unsigned long outbuf_clock = 0; /* source of LRU stamps */
+struct outbuf_t doneouts[MAXJOBS]; /* output of finished jobs, oldest first */
+int ndone = 0;              /* number of doneouts waiting for the next prompt */
+unsigned long donelost = 0; /* bytes of finished jobs' output with no doneouts slot */
+
+struct zygote_t {           /* An idle child parked just before exec */
+    pid_t pid;              /* zygote PID, 0 if the slot is empty */
+    int sock;               /* shell end of the socketpair it listens on */
+};
+struct zygote_t zygotes[MAXZYGOTES]; /* The pre-forked pool */
 /* End global variables */
 
 
@@ -67,6 +144,7 @@ void waitfg(pid_t pid);
 void sigchld_handler(int sig);
 void sigtstp_handler(int sig);
 void sigint_handler(int sig);
+void sigio_handler(int sig);
 
 /* Here are helper routines that we've provided for you */
 int parseline(const char *cmdline, char **argv);
@@ -82,7 +160,36 @@ struct job_t *getjobpid(struct job_t *jobs, pid_t pid);
 struct job_t *getjobjid(struct job_t *jobs, int jid);
 int pid2jid(pid_t pid);
 void listjobs(struct job_t *jobs);
-
+struct jobinfo_t *getjobinfo(struct job_t *job);
+char *jobcmdline(struct job_t *job);
+int cmdintern(const char *cmdline);
+
+long long now(void);
+long long parseduration(const char *s);
+void settimeout(struct job_t *job, long long ns);
+void checkdeadlines(void);
+void waitinput(void);
+void dlheap_sift(int pos);
+void dlheap_remove(int i);
+void armtimer(void);
+
+void drainjob(struct job_t *job);
+void endcapture(struct job_t *job);
+void outbuf_append(struct outbuf_t *ob, const char *buf, int n);
+void outbuf_drop(struct outbuf_t *ob);
+struct outbuf_t *outbuf_lru(void);
+void outbuf_write(struct outbuf_t *ob);
+void outbuf_clear(struct outbuf_t *ob);
+void do_joboutput(char **argv);
+void showdone(void);
+
+int refillzygote(void);
+int zygotefree(void);
+void zygote_main(int sock);
+pid_t zygote_launch(char **argv, int outfd);
+
+int readcmd(char *cmdline);
+int stdinbuffered(void);
 void usage(void);
 void unix_error(char *msg);
 void app_error(char *msg);
@@ -103,7 +210,7 @@ int main(int argc, char **argv)
     dup2(1, 2);
 
     /* Parse the command line */
-    while ((c = getopt(argc, argv, "hvp")) != EOF) {
+    while ((c = getopt(argc, argv, "hvpoz:")) != EOF) {
         switch (c) {
         case 'h':             /* print help message */
             usage();
@@ -114,6 +221,14 @@ int main(int argc, char **argv)
         case 'p':             /* don't print a prompt */
             emit_prompt = 0;  /* handy for automatic testing */
 	    break;
+        case 'o':             /* capture background job output */
+            capture = 1;
+	    break;
+        case 'z':             /* keep a pool of pre-forked children */
+            nzygotes = atoi(optarg);
+            if (nzygotes < 0 || nzygotes > MAXZYGOTES)
+                usage();
+	    break;
 	default:
             usage();
 	}
@@ -125,6 +240,7 @@ int main(int argc, char **argv)
     Signal(SIGINT,  sigint_handler);   /* ctrl-c */
     Signal(SIGTSTP, sigtstp_handler);  /* ctrl-z */
     Signal(SIGCHLD, sigchld_handler);  /* Terminated or stopped child */
+    Signal(SIGIO,   sigio_handler);    /* Captured job output is ready */
 
     /* Ignoring these signals simplifies reading from stdin/stdout */
     Signal(SIGTTIN, SIG_IGN);          /* ignore SIGTTIN */
@@ -140,14 +256,16 @@ int main(int argc, char **argv)
     /* Execute the shell's read/eval loop */
     while (1) {
 
+	/* Show what finished background jobs wrote, if -o */
+	showdone();
+
 	/* Read command line */
 	if (emit_prompt) {
 	    printf("%s", prompt);
 	    fflush(stdout);
 	}
-	if ((fgets(cmdline, MAXLINE, stdin) == NULL) && ferror(stdin))
-	    app_error("fgets error");
-	if (feof(stdin)) { /* End of file (ctrl-d) */
+	waitinput(); /* fire job timeouts and refill the zygote pool while we sit at the prompt */
+	if (!readcmd(cmdline)) { /* End of file (ctrl-d) */
 	    fflush(stdout);
 	    exit(0);
 	}
@@ -166,7 +284,9 @@ int main(int argc, char **argv)
  *
  * If the user has requested a built-in command (quit, jobs, bg or fg)
  * then execute it immediately. Otherwise, fork a child process and
- * run the job in the context of the child. If the job is running in
+ * run the job in the context of the child. A leading "timeout DURATION"
+ * gives the job a deadline, after which it is sent SIGTERM and, if it
+ * is still around KILLGRACE seconds later, SIGKILL. If the job is running in
  * the foreground, wait for it to terminate and then return.  Note:
  * each child process must have a unique process group ID so that our
  * background children don't receive SIGINT (SIGTSTP) from the kernel
@@ -177,11 +297,16 @@ void eval(char *cmdline)
     char *argv[MAXLINE];
     int bg = parseline(cmdline, argv); /* set to true if parseline determines the command shld be running in background, false if foreground */
     pid_t pid;
+    int outpipe[2] = {-1, -1}; /* capture pipe for a background job, if -o */
+    long long timeout = 0; /* ns until the job is killed, 0 for no timeout */
+    struct job_t *job;
+    int i;
 
     /* gets the SIGCHLD mask ready to avoid race conditions */
     sigset_t mask, prev_mask;
     sigemptyset(&mask);
     sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGIO);
 
 
     /* In order to ignore whitespace, we just do nothing when white space (null values). */
@@ -189,18 +314,46 @@ void eval(char *cmdline)
         return;
     }
 
+    /* "timeout DURATION cmd ..." runs cmd as the job itself, with a deadline, instead of a wrapper process */
+    if (strcmp(argv[0], "timeout") == 0) {
+        if (argv[1] == NULL || argv[2] == NULL || (timeout = parseduration(argv[1])) < 0) {
+            printf("timeout: usage: timeout DURATION[s|m|h|d] command\n");
+            return;
+        }
+        for (i = 0; argv[i + 2]; i++)
+            argv[i] = argv[i + 2];
+        argv[i] = NULL;
+    }
+
     /* Check if the command is a built-in command. If not, fork a child process and execute the specified program. */
     if (!builtin_cmd(argv)){
+#ifdef LAUNCH_BENCH
+        printf("P %lld\n", now()); // bench/launch.sh: when the launch started
+        fflush(stdout);
+#endif
 
         /* Block the SIGCHLD signal while we are adding the job to the job list and executing the command. */
         sigprocmask(SIG_BLOCK, &mask, &prev_mask);
-        // fork & exec specified program
-        pid = fork();
+
+        /* With -o, a background job writes into a pipe that the shell drains
+           into the job's ring buffer instead of straight to the terminal. */
+        if (capture && bg && pipe(outpipe) < 0)
+            unix_error("pipe error");
+
+        // hand the command to an idle zygote if there is one, otherwise fork & exec specified program
+        if (nzygotes == 0 || (pid = zygote_launch(argv, outpipe[1])) <= 0)
+            pid = fork();
 
         if (pid == 0){ // pid = 0 means child process
             setpgid(0,0); // set child process group PID to 0 to prevent race conditions
             /* We are in the child process. Unblock the SIGCHLD signal and execute the command. */
             sigprocmask(SIG_UNBLOCK, &mask, &prev_mask);
+            if (outpipe[1] >= 0) { // stdout and stderr go to the capture pipe; redirects below still win
+                close(outpipe[0]);
+                dup2(outpipe[1], STDOUT_FILENO);
+                dup2(outpipe[1], STDERR_FILENO);
+                close(outpipe[1]);
+            }
             do_redirect(argv);
             if (execve(argv[0], argv, environ) < 0){ // execve will return -1 if there was an error.
                 /* If there was an error executing the command, print an error message and exit. */
@@ -214,6 +367,8 @@ void eval(char *cmdline)
             if (!bg){ // Foreground
               /* Add the job to the job list, unblock the SIGCHLD signal, and wait for the job to finish. */
                 addjob(jobs, pid, FG, cmdline);
+                if (timeout > 0 && (job = getjobpid(jobs, pid)) != NULL)
+                    settimeout(job, timeout);
                 sigprocmask(SIG_UNBLOCK, &mask, &prev_mask);
                 waitfg(pid); // wait for any previous foreground jobs to finish
 
@@ -222,6 +377,20 @@ void eval(char *cmdline)
                 /* Add the job to the job list, unblock the SIGCHLD signal,
                 and print a message indicating that it is running in the background. */
                 addjob(jobs, pid, BG, cmdline);
+                if (timeout > 0 && (job = getjobpid(jobs, pid)) != NULL)
+                    settimeout(job, timeout);
+                if (outpipe[0] >= 0) {
+                    /* keep the read end out of later children and have the kernel
+                       send us SIGIO whenever the job writes something */
+                    close(outpipe[1]);
+                    fcntl(outpipe[0], F_SETFD, FD_CLOEXEC);
+                    fcntl(outpipe[0], F_SETOWN, getpid());
+                    fcntl(outpipe[0], F_SETFL, O_NONBLOCK | O_ASYNC);
+                    if ((job = getjobpid(jobs, pid)) != NULL)
+                        getjobinfo(job)->outfd = outpipe[0];
+                    else
+                        close(outpipe[0]);
+                }
                 sigprocmask(SIG_UNBLOCK, &mask, &prev_mask);
                 int jobid = pid2jid(pid);
                 printf("[%d] (%d) %s", jobid, pid, cmdline);
@@ -298,7 +467,10 @@ int builtin_cmd(char **argv) // DONE
         exit(0);
     }
     else if (strcmp(argv[0], "jobs") == 0){ /*if "jobs", call the listjobs function which is predefined. */
-        listjobs(jobs);
+        if (argv[1] != NULL && strcmp(argv[1], "-o") == 0) /* "jobs -o %jid" shows captured output instead */
+            do_joboutput(argv);
+        else
+            listjobs(jobs);
         return 1;
     }
     /* if either bg or fg, enter the do_bgfg function which has been implemented. */
@@ -318,6 +490,9 @@ int builtin_cmd(char **argv) // DONE
 /*
  * do_redirect - scans argv for any use of < or > which indicate input or output redirection
  *
+ * Runs in the child (or zygote) before exec. Errors leave with _exit, since
+ * exit() would seek the stdin offset we share with the shell back to
+ * wherever our inherited copy of its stdin buffer was.
  */
 void do_redirect(char **argv)
 {
@@ -332,13 +507,15 @@ void do_redirect(char **argv)
             // read, write, truncate, or create with edit permissions to all
             if (input_f < 0){
                 printf("error");
-                exit(1);
+                fflush(stdout);
+                _exit(1);
             }
 
             //file descriptor
             if (dup2(input_f, STDIN_FILENO) < 0){
                 printf("error");
-                exit(1);
+                fflush(stdout);
+                _exit(1);
             }
             /* the line below cuts argv short. This
                 removes the < and whatever follows from argv */
@@ -354,12 +531,14 @@ void do_redirect(char **argv)
             // read, write, truncate, or create with edit permissions to all
             if (output_f < 0){
                 printf("error");
-                exit(1);
+                fflush(stdout);
+                _exit(1);
             }
             // file descriptor
             if (dup2(output_f, STDOUT_FILENO) < 0){
                 printf("error");
-                exit(1);
+                fflush(stdout);
+                _exit(1);
             }
 
             /* the line below cuts argv short. This removes the > and whatever follows from argv */
@@ -419,11 +598,25 @@ void do_bgfg(char **argv)
 
     if(strcmp(argv[0], "bg") == 0) {  // BACKGROUND CALL
         currentJob->state = BG;  // change state to BG
-        printf("[%d] (%d) %s", currentJob->jid, currentJob->pid, currentJob->cmdline);
+        printf("[%d] (%d) %s", currentJob->jid, currentJob->pid, jobcmdline(currentJob));
         kill(-currentJob->pid, SIGCONT);  // send SIGCONT to processes telling it to resume
     }
      else if (strcmp(argv[0], "fg") == 0){ // FOREGROUND CALL
+        /* flush whatever the job wrote while in the background, then mark it FG so
+           sigio_handler passes any further output straight through, in order */
+        sigset_t mask, prev_mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGIO);
+        sigaddset(&mask, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+        drainjob(currentJob);
+        if (outbufs[currentJob - jobs].dropped > 0)
+            printf("[%d] (%d) %lu bytes of earlier output dropped\n",
+                   currentJob->jid, currentJob->pid, outbufs[currentJob - jobs].dropped);
+        outbuf_write(&outbufs[currentJob - jobs]);
+        outbuf_clear(&outbufs[currentJob - jobs]);
         currentJob->state = FG; // change state to FG
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
         kill(-currentJob->pid, SIGCONT); // send SIGCONT to processes telling it to resume
         waitfg(currentJob->pid); // make sure all current FG processes are done
     }
@@ -437,8 +630,14 @@ void do_bgfg(char **argv)
  */
 void waitfg(pid_t pid) // DONE
 {
+    struct pollfd pfd = { timerfd, POLLIN, 0 };
+
     while (fgpid(jobs) == pid){ // while fgpid is the pid passed in, sleep and keep checking until it is removed
-        sleep(1);
+        if (refillzygote()) // the shell is idle meanwhile, so top up the pool
+            continue;
+        pfd.fd = timerfd;
+        if (poll(&pfd, timerfd >= 0, 1000) > 0) // like sleep(1), but wakes up for job timeouts
+            checkdeadlines();
     }
     return;
 }
@@ -458,6 +657,13 @@ void sigchld_handler(int sig) // DONE
 {
     pid_t pid;
     int stat; // need this for waitpid to return status id
+    struct job_t *job;
+    sigset_t mask, prev_mask;
+
+    /* deletejob flushes captured output, so keep sigio_handler out meanwhile */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGIO);
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
 
     // Use waitpid to reap all available zombie children
     /* WAITPID PARAMETER EXPLANATION:
@@ -467,10 +673,23 @@ void sigchld_handler(int sig) // DONE
     WUNTRACED: return if a child process has been stopped (but not necessarily terminated)
     */
     while ((pid = waitpid(-1, &stat, WNOHANG|WUNTRACED)) > 0) {
+        int i;
+        for (i = 0; i < nzygotes; i++) // an idle zygote died before it was handed a job
+            if (zygotes[i].pid == pid) {
+                close(zygotes[i].sock);
+                zygotes[i].pid = 0;
+                break;
+            }
+        if (i < nzygotes)
+            continue;
+
+        if ((job = getjobpid(jobs, pid)) != NULL) // deletejob hands it on with any captured output
+            getjobinfo(job)->status = stat;
+
         // Check if the child process terminated normally or due to a signa
         if (WIFSIGNALED(stat)) { //SIGINT catcher
             int jobid = pid2jid(pid); //jid needed for return message
-            printf("Job [%d] (%d) terminated by signal 2\n", jobid, pid); // standard message to be called based on traces
+            printf("Job [%d] (%d) terminated by signal %d\n", jobid, pid, WTERMSIG(stat)); // standard message to be called based on traces
             deletejob(jobs, pid); // delete the job if terminated
 
         }
@@ -484,9 +703,8 @@ void sigchld_handler(int sig) // DONE
         else { /* if the child completed with no issues, just remove it from the job list. */
             deletejob(jobs, pid); // Delete the child from the job list
         }
-
-    return;
     }
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
 }
 
 
@@ -518,6 +736,26 @@ void sigtstp_handler(int sig) // DONE
 
 }
 
+/*
+ * sigio_handler - The kernel sends a SIGIO to the shell whenever a
+ *     background job started with -o writes to its capture pipe. Drain
+ *     every pipe into its job's ring buffer (or to the terminal if the
+ *     job has since been brought to the foreground).
+ */
+void sigio_handler(int sig)
+{
+    int i;
+    sigset_t mask, prev_mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD); // sigchld_handler may delete the job we are draining
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+    for (i = 0; i < MAXJOBS; i++)
+        if (jobinfo[i].outfd >= 0)
+            drainjob(&jobs[i]);
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+
 /*********************
  * End signal handlers
  *********************/
@@ -526,20 +764,37 @@ void sigtstp_handler(int sig) // DONE
  * Helper routines that manipulate the job list
  **********************************************/
 
-/* clearjob - Clear the entries in a job struct */
+/* clearjob - Clear the entries in a job struct, releasing its command line */
 void clearjob(struct job_t *job) {
+    struct jobinfo_t *info = getjobinfo(job);
+
     job->pid = 0;
     job->jid = 0;
     job->state = UNDEF;
-    job->cmdline[0] = '\0';
+    if (info->cmdoff >= 0) {
+        cmdarena_live -= info->cmdlen + 1;
+        if (cmdarena_live == 0) /* last one out empties the arena */
+            cmdarena_used = 0;
+    }
+    info->cmdoff = -1;
+    info->cmdlen = 0;
+    info->outfd = -1;
+    if (info->heapidx >= 0)
+        dlheap_remove(job - jobs);
+    info->deadline = 0;
+    info->termsent = 0;
+    info->status = 0;
 }
 
 /* initjobs - Initialize the job list */
 void initjobs(struct job_t *jobs) {
     int i;
 
-    for (i = 0; i < MAXJOBS; i++)
+    for (i = 0; i < MAXJOBS; i++) {
+	jobinfo[i].cmdoff = -1;
+	jobinfo[i].heapidx = -1;
 	clearjob(&jobs[i]);
+    }
 }
 
 /* maxjid - Returns largest allocated job ID */
@@ -568,9 +823,10 @@ int addjob(struct job_t *jobs, pid_t pid, int state, char *cmdline)
 	    jobs[i].jid = nextjid++;
 	    if (nextjid > MAXJOBS)
 		nextjid = 1;
-	    strcpy(jobs[i].cmdline, cmdline);
+	    jobinfo[i].cmdlen = strlen(cmdline);
+	    jobinfo[i].cmdoff = cmdintern(cmdline);
   	    if(verbose){
-	        printf("Added job [%d] %d %s\n", jobs[i].jid, jobs[i].pid, jobs[i].cmdline);
+	        printf("Added job [%d] %d %s\n", jobs[i].jid, jobs[i].pid, jobcmdline(&jobs[i]));
             }
             return 1;
 	}
@@ -589,6 +845,7 @@ int deletejob(struct job_t *jobs, pid_t pid)
 
     for (i = 0; i < MAXJOBS; i++) {
 	if (jobs[i].pid == pid) {
+	    endcapture(&jobs[i]);
 	    clearjob(&jobs[i]);
 	    nextjid = maxjid(jobs)+1;
 	    return 1;
@@ -668,28 +925,718 @@ void listjobs(struct job_t *jobs)
 		    printf("listjobs: Internal error: job[%d].state=%d ",
 			   i, jobs[i].state);
 	    }
-	    printf("%s", jobs[i].cmdline);
+	    printf("%s", jobcmdline(&jobs[i]));
 	}
     }
 }
+/* getjobinfo - Return the cold half of a job's record */
+struct jobinfo_t *getjobinfo(struct job_t *job)
+{
+    return &jobinfo[job - jobs];
+}
+
+/* jobcmdline - Return a job's command line, or "" if it has none */
+char *jobcmdline(struct job_t *job)
+{
+    struct jobinfo_t *info = getjobinfo(job);
+
+    return info->cmdoff >= 0 ? &cmdarena[info->cmdoff] : "";
+}
+
+/*
+ * cmdintern - Copy a command line into cmdarena and return its offset.
+ *    Space left behind by deleted jobs is reclaimed by sliding the live
+ *    command lines down before the arena is grown. Callers must have
+ *    SIGCHLD blocked, since deletejob releases arena space too.
+ */
+int cmdintern(const char *cmdline)
+{
+    int i, j, off, len = strlen(cmdline) + 1;
+
+    if (cmdarena_used + len > cmdarena_size && cmdarena_live < cmdarena_used) {
+        for (off = 0; ; off += jobinfo[j].cmdlen + 1) { /* compact, lowest offset first */
+            j = -1;
+            for (i = 0; i < MAXJOBS; i++)
+                if (jobinfo[i].cmdoff >= off && (j < 0 || jobinfo[i].cmdoff < jobinfo[j].cmdoff))
+                    j = i;
+            if (j < 0)
+                break;
+            memmove(&cmdarena[off], &cmdarena[jobinfo[j].cmdoff], jobinfo[j].cmdlen + 1);
+            jobinfo[j].cmdoff = off;
+        }
+        cmdarena_used = off;
+    }
+    if (cmdarena_used + len > cmdarena_size) {
+        cmdarena_size = cmdarena_size * 2 > MAXLINE ? cmdarena_size * 2 : MAXLINE;
+        if (cmdarena_size < cmdarena_used + len)
+            cmdarena_size = cmdarena_used + len;
+        if ((cmdarena = realloc(cmdarena, cmdarena_size)) == NULL)
+            unix_error("realloc error");
+    }
+
+    off = cmdarena_used;
+    memcpy(&cmdarena[off], cmdline, len);
+    cmdarena_used += len;
+    cmdarena_live += len;
+    return off;
+}
 /******************************
  * end job list helper routines
  ******************************/
 
 
+/*****************************************************
+ * Helper routines for capturing background job output
+ *
+ * Callers must have SIGIO and SIGCHLD blocked.
+ *****************************************************/
+
+/* drainjob - Read everything currently in a job's capture pipe */
+void drainjob(struct job_t *job)
+{
+    struct jobinfo_t *info = getjobinfo(job);
+    char buf[4096];
+    int n, off, w;
+
+    while (info->outfd >= 0) {
+        n = read(info->outfd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) /* EAGAIN: nothing more for now */
+            break;
+        if (n == 0) { /* every writer has exited */
+            close(info->outfd);
+            info->outfd = -1;
+            break;
+        }
+        if (job->state == FG) { /* fg'd jobs write through to the terminal */
+            for (off = 0; off < n; off += w)
+                if ((w = write(STDOUT_FILENO, buf + off, n - off)) < 0)
+                    break;
+        }
+        else
+            outbuf_append(&outbufs[job - jobs], buf, n);
+    }
+}
+
+/*
+ * endcapture - Set aside a job's captured output when it is deleted.
+ *    We are usually in sigchld_handler here, possibly with a foreground
+ *    job printing, so the output waits in doneouts for showdone.
+ */
+void endcapture(struct job_t *job)
+{
+    struct jobinfo_t *info = getjobinfo(job);
+    struct outbuf_t *ob = &outbufs[job - jobs];
+
+    drainjob(job);
+    if (info->outfd >= 0) { /* a grandchild may still hold the pipe open */
+        close(info->outfd);
+        info->outfd = -1;
+    }
+    if (ob->first == NULL && ob->dropped == 0)
+        return;
+
+    if (ndone == MAXJOBS) { /* the oldest finished job's output gives way */
+        donelost += doneouts[0].len;
+        outbuf_clear(&doneouts[0]);
+        memmove(&doneouts[0], &doneouts[1], (MAXJOBS - 1) * sizeof(doneouts[0]));
+        ndone--;
+    }
+    doneouts[ndone] = *ob;
+    doneouts[ndone].jid = job->jid;
+    doneouts[ndone].pid = job->pid;
+    doneouts[ndone].status = info->status;
+    ndone++;
+    memset(ob, 0, sizeof(*ob));
+}
+
+/*
+ * outbuf_append - Append n bytes to a job's captured output. The oldest
+ *    chunks of the same job make room first; once the pool is used up,
+ *    the least recently used buffer across the table gives up its oldest
+ *    chunk.
+ */
+void outbuf_append(struct outbuf_t *ob, const char *buf, int n)
+{
+    struct outchunk_t *c;
+    int chunk;
+
+    if (n > OUTBUF_JOB) { /* only the newest OUTBUF_JOB bytes can survive */
+        ob->dropped += n - OUTBUF_JOB;
+        buf += n - OUTBUF_JOB;
+        n = OUTBUF_JOB;
+    }
+    while (ob->len + n > OUTBUF_JOB)
+        outbuf_drop(ob);
+
+    while (n > 0) {
+        if (ob->last == NULL || ob->last->len == OUTCHUNK) {
+            if ((c = outfree) != NULL)
+                outfree = c->next;
+            else if (outpool_next < OUTBUF_MAX / OUTCHUNK)
+                c = &outpool[outpool_next++];
+            else { /* pool is full: evict and try again */
+                outbuf_drop(outbuf_lru());
+                continue;
+            }
+            c->next = NULL;
+            c->len = 0;
+            if (ob->last != NULL)
+                ob->last->next = c;
+            else
+                ob->first = c;
+            ob->last = c;
+        }
+        chunk = OUTCHUNK - ob->last->len < n ? OUTCHUNK - ob->last->len : n;
+        memcpy(ob->last->data + ob->last->len, buf, chunk);
+        ob->last->len += chunk;
+        ob->len += chunk;
+        buf += chunk;
+        n -= chunk;
+    }
+    ob->lastuse = ++outbuf_clock;
+}
+
+/* outbuf_drop - Evict the oldest chunk of a buffer, returning it to the pool */
+void outbuf_drop(struct outbuf_t *ob)
+{
+    struct outchunk_t *c = ob->first;
+
+    ob->first = c->next;
+    if (ob->first == NULL)
+        ob->last = NULL;
+    ob->len -= c->len;
+    ob->dropped += c->len;
+    c->next = outfree;
+    outfree = c;
+}
+
+/* outbuf_lru - Return the least recently used buffer that holds any output */
+struct outbuf_t *outbuf_lru(void)
+{
+    struct outbuf_t *lru = NULL;
+    int i;
+
+    for (i = 0; i < MAXJOBS; i++)
+        if (outbufs[i].first != NULL && (lru == NULL || outbufs[i].lastuse < lru->lastuse))
+            lru = &outbufs[i];
+    for (i = 0; i < ndone; i++)
+        if (doneouts[i].first != NULL && (lru == NULL || doneouts[i].lastuse < lru->lastuse))
+            lru = &doneouts[i];
+    return lru;
+}
+
+/* outbuf_write - Write the contents of a buffer to stdout, oldest first */
+void outbuf_write(struct outbuf_t *ob)
+{
+    struct outchunk_t *c;
+    int off, w;
+
+    fflush(stdout); // keep anything we printf'd earlier in front of it
+    for (c = ob->first; c != NULL; c = c->next)
+        for (off = 0; off < c->len; off += w)
+            if ((w = write(STDOUT_FILENO, c->data + off, c->len - off)) < 0)
+                return;
+}
+
+/* outbuf_clear - Empty a buffer once its contents have been shown for good */
+void outbuf_clear(struct outbuf_t *ob)
+{
+    while (ob->first != NULL)
+        outbuf_drop(ob);
+    ob->dropped = 0;
+}
+
+/*
+ * do_joboutput - Execute "jobs -o %jid": show a job's captured output
+ *    without consuming it, so fg still flushes it later.
+ */
+void do_joboutput(char **argv)
+{
+    struct job_t *job;
+    struct outbuf_t *ob;
+    sigset_t mask, prev_mask;
+
+    if (argv[2] == NULL || argv[2][0] != '%') {
+        printf("jobs -o command requires %%jobid argument\n");
+        return;
+    }
+    if ((job = getjobjid(jobs, atoi(&argv[2][1]))) == NULL) {
+        printf("%s: No such job\n", argv[2]);
+        return;
+    }
+    ob = &outbufs[job - jobs];
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGIO);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+    drainjob(job);
+    if (ob->dropped > 0)
+        printf("[%d] (%d) %lu bytes of earlier output dropped\n",
+               job->jid, job->pid, ob->dropped);
+    outbuf_write(ob);
+    ob->lastuse = ++outbuf_clock;
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+/*
+ * showdone - Write out the captured output of background jobs that have
+ *    finished since the last prompt, one job at a time. Jobs that exited
+ *    get a "Done" line; those killed by a signal were already reported
+ *    by sigchld_handler, so their output just gets an "Output" line.
+ */
+void showdone(void)
+{
+    sigset_t mask, prev_mask;
+    int i;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGIO);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+    for (i = 0; i < ndone; i++) {
+        if (WIFSIGNALED(doneouts[i].status)) // sigchld_handler has reported that already
+            printf("[%d] (%d) Output\n", doneouts[i].jid, doneouts[i].pid);
+        else
+            printf("[%d] (%d) Done\n", doneouts[i].jid, doneouts[i].pid);
+        if (doneouts[i].dropped > 0)
+            printf("[%d] (%d) %lu bytes of earlier output dropped\n",
+                   doneouts[i].jid, doneouts[i].pid, doneouts[i].dropped);
+        outbuf_write(&doneouts[i]);
+        outbuf_clear(&doneouts[i]);
+    }
+    ndone = 0;
+    if (donelost > 0) {
+        printf("%lu bytes of output from finished jobs dropped\n", donelost);
+        donelost = 0;
+    }
+    fflush(stdout);
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+/*************************************
+ * end output capture helper routines
+ *************************************/
+
+
+/*****************************************************************
+ * Helper routines for the pre-forked zygote pool
+ *
+ * A zygote is a child forked ahead of time, already in its own process
+ * group with default signal handling, blocked on a socketpair. Handing
+ * it a command skips the fork on the launch path: the shell sends the
+ * argv strings plus the fds to use as stdin/stdout/stderr (SCM_RIGHTS),
+ * and the zygote applies them, runs do_redirect and execs. The
+ * environment is inherited at fork time; tsh never changes it.
+ *
+ * The pool is only refilled while the shell would otherwise be idle:
+ * at the prompt with no input pending (waitinput) and while waiting
+ * for a foreground job (waitfg). A burst of commands drains the pool
+ * and then falls back to fork() rather than paying for refills.
+ *****************************************************************/
+
+/* refillzygote - Fork a zygote into an empty slot; returns 0 if the pool is full */
+int refillzygote(void)
+{
+    int i, sv[2];
+    pid_t pid;
+    sigset_t mask, prev_mask;
+
+    if (!zygotefree())
+        return 0;
+    for (i = 0; zygotes[i].pid != 0; i++)
+        ;
+
+    /* until the slot records its PID, sigchld_handler would take a dying zygote for a job */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+
+    fflush(stdout); // don't let the zygote inherit (and later re-flush) pending output
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0)
+        unix_error("socketpair error");
+    if ((pid = fork()) < 0)
+        unix_error("fork error");
+    if (pid == 0) {
+        close(sv[0]);
+        zygote_main(sv[1]); // sets its own signal mask
+    }
+    setpgid(pid, pid); // same as the zygote does itself, so either order is fine
+    close(sv[1]);
+    zygotes[i].pid = pid;
+    zygotes[i].sock = sv[0];
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+    return 1;
+}
+
+/* zygotefree - Return true if the pool has an empty slot to refill */
+int zygotefree(void)
+{
+    int i;
+
+    for (i = 0; i < nzygotes; i++)
+        if (zygotes[i].pid == 0)
+            return 1;
+    return 0;
+}
+
+/* zygote_main - Body of a zygote: wait for one command, then exec it */
+void zygote_main(int sock)
+{
+    char buf[MAXLINE];
+    char *argv[MAXARGS];
+    char cbuf[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov = { buf, sizeof(buf) - 1 };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fds[3], argc, i, n;
+    sigset_t empty;
+
+    setpgid(0, 0);
+    Signal(SIGINT, SIG_DFL);  // the shell's handlers would act on our stale job list
+    Signal(SIGTSTP, SIG_DFL);
+    Signal(SIGCHLD, SIG_DFL);
+    Signal(SIGIO, SIG_DFL);
+    Signal(SIGQUIT, SIG_DFL);
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, NULL);
+    for (i = 0; i < MAXZYGOTES; i++) // only the shell may hold the other zygotes' sockets
+        if (zygotes[i].pid != 0)
+            close(zygotes[i].sock);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    while ((n = recvmsg(sock, &msg, 0)) < 0 && errno == EINTR)
+        ;
+    if (n <= 0) // the shell went away without using us; _exit leaves its stdin offset alone
+        _exit(0);
+    if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL || cmsg->cmsg_type != SCM_RIGHTS)
+        _exit(1);
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    close(sock);
+
+    /* rebuild argv from the NUL-separated strings */
+    buf[n] = '\0';
+    for (argc = 0, i = 0; i < n && argc < MAXARGS - 1; i += strlen(&buf[i]) + 1)
+        argv[argc++] = &buf[i];
+    argv[argc] = NULL;
+
+    for (i = 0; i < 3; i++)
+        dup2(fds[i], i);
+    for (i = 0; i < 3; i++)
+        if (fds[i] > 2)
+            close(fds[i]);
+
+    do_redirect(argv);
+    if (execve(argv[0], argv, environ) < 0){
+        /* our stdin buffer is from whenever we were forked, so exit() would
+           seek the shared offset back and make the shell re-read old lines */
+        printf("%s: Command not found\n", argv[0]);
+        fflush(stdout);
+        _exit(0);
+    }
+}
+
+/*
+ * zygote_launch - Hand argv to an idle zygote. If outfd >= 0 it becomes
+ *    the job's stdout and stderr. Returns the zygote's PID, which is now
+ *    the job's PID, or 0 if the pool is empty or argv has more than a
+ *    zygote can take (MAXARGS-1), in which case the caller forks.
+ */
+pid_t zygote_launch(char **argv, int outfd)
+{
+    char buf[MAXLINE];
+    char cbuf[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fds[3], i, len, n;
+    pid_t pid;
+
+    for (i = 0; i < nzygotes; i++)
+        if (zygotes[i].pid != 0)
+            break;
+    if (i == nzygotes)
+        return 0;
+    for (n = 0; argv[n]; n++)
+        ;
+    if (n >= MAXARGS)
+        return 0;
+
+    for (len = 0, n = 0; argv[n]; n++) {
+        strcpy(&buf[len], argv[n]); // argv came out of a MAXLINE command line, so it fits
+        len += strlen(argv[n]) + 1;
+    }
+    fds[0] = STDIN_FILENO;
+    fds[1] = outfd >= 0 ? outfd : STDOUT_FILENO;
+    fds[2] = outfd >= 0 ? outfd : STDERR_FILENO;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    pid = zygotes[i].pid;
+    n = sendmsg(zygotes[i].sock, &msg, MSG_NOSIGNAL);
+    close(zygotes[i].sock);
+    zygotes[i].pid = 0;
+    if (n < 0) { // it died under us; sigchld_handler can't find it anymore, so reap it here
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return 0;
+    }
+    return pid;
+}
+/**********************************
+ * end zygote pool helper routines
+ **********************************/
+
+
+/*****************************************************************
+ * Helper routines for job deadlines
+ *
+ * Deadlines live in dlheap, a min-heap of jobs[] indexes keyed on
+ * jobinfo[].deadline, and a single timerfd is kept armed for the
+ * earliest one. deletejob drops a job from the heap from within
+ * sigchld_handler, so callers in the shell proper must have SIGCHLD
+ * blocked.
+ *****************************************************************/
+
+/* now - Return CLOCK_MONOTONIC in ns */
+long long now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * parseduration - Parse a timeout(1)-style DURATION: a number with an
+ *    optional s, m, h or d suffix. Returns ns, or -1 if malformed.
+ *    Durations past MAXTIMEOUT are clamped to it.
+ */
+long long parseduration(const char *s)
+{
+    char *end;
+    double secs = strtod(s, &end);
+
+    if (end == s || !isfinite(secs) || secs < 0) // strtod also takes "nan" and "inf"
+        return -1;
+    switch (*end) {
+    case '\0': case 's': break;
+    case 'm': secs *= 60; break;
+    case 'h': secs *= 60 * 60; break;
+    case 'd': secs *= 24 * 60 * 60; break;
+    default: return -1;
+    }
+    if (*end != '\0' && end[1] != '\0')
+        return -1;
+    if (secs > MAXTIMEOUT)
+        secs = MAXTIMEOUT;
+    return (long long)(secs * 1e9);
+}
+
+/* settimeout - Give a job a deadline ns from now */
+void settimeout(struct job_t *job, long long ns)
+{
+    struct jobinfo_t *info = getjobinfo(job);
+
+    if (timerfd < 0 && (timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+        unix_error("timerfd_create error");
+
+    info->deadline = now() + ns;
+    info->termsent = 0;
+    dlheap[dlheap_len] = job - jobs;
+    dlheap_sift(dlheap_len++);
+    armtimer();
+}
+
+/*
+ * checkdeadlines - Signal every job whose deadline has passed: SIGTERM
+ *    (plus SIGCONT if it is stopped) first, then SIGKILL KILLGRACE
+ *    seconds later if it hasn't exited.
+ *    Their exit is reported by sigchld_handler like any other.
+ */
+void checkdeadlines(void)
+{
+    unsigned long long expirations;
+    sigset_t mask, prev_mask;
+    long long t;
+    int i;
+
+    while (read(timerfd, &expirations, sizeof(expirations)) > 0) // just clear it; the heap is what counts
+        ;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &prev_mask);
+    t = now();
+    while (dlheap_len > 0 && jobinfo[dlheap[0]].deadline <= t) {
+        i = dlheap[0];
+        if (!jobinfo[i].termsent) {
+            kill(-jobs[i].pid, SIGTERM);
+            if (jobs[i].state == ST) { // like timeout(1): a stopped job can't act on SIGTERM
+                kill(-jobs[i].pid, SIGCONT);
+                jobs[i].state = BG;
+            }
+            jobinfo[i].termsent = 1;
+            jobinfo[i].deadline = t + KILLGRACE * 1000000000LL;
+            dlheap_sift(0);
+        }
+        else {
+            kill(-jobs[i].pid, SIGKILL);
+            dlheap_remove(i);
+        }
+    }
+    armtimer();
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+
+/*
+ * waitinput - Block until stdin is readable. Meanwhile fire job timeouts
+ *    and, for as long as nothing has been typed, refill the zygote pool.
+ */
+void waitinput(void)
+{
+    struct pollfd pfds[2];
+    int refill, n;
+
+    while (!stdinbuffered() && ((refill = zygotefree()) || dlheap_len > 0)) {
+        pfds[0].fd = STDIN_FILENO;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = dlheap_len > 0 ? timerfd : -1; // poll skips negative fds
+        pfds[1].events = POLLIN;
+        if ((n = poll(pfds, 2, refill ? 0 : -1)) < 0) {
+            if (errno == EINTR) // e.g. SIGCHLD: the heap may be empty now
+                continue;
+            unix_error("poll error");
+        }
+        if (pfds[1].revents & POLLIN)
+            checkdeadlines();
+        if (pfds[0].revents)
+            return;
+        if (n == 0)
+            refillzygote();
+    }
+}
+
+/* dlheap_sift - Move the entry at pos up or down until the heap is in order */
+void dlheap_sift(int pos)
+{
+    int i = dlheap[pos], parent, child;
+
+    while (pos > 0 && jobinfo[dlheap[parent = (pos - 1) / 2]].deadline > jobinfo[i].deadline) {
+        dlheap[pos] = dlheap[parent];
+        jobinfo[dlheap[pos]].heapidx = pos;
+        pos = parent;
+    }
+    while ((child = 2 * pos + 1) < dlheap_len) {
+        if (child + 1 < dlheap_len && jobinfo[dlheap[child + 1]].deadline < jobinfo[dlheap[child]].deadline)
+            child++;
+        if (jobinfo[dlheap[child]].deadline >= jobinfo[i].deadline)
+            break;
+        dlheap[pos] = dlheap[child];
+        jobinfo[dlheap[pos]].heapidx = pos;
+        pos = child;
+    }
+    dlheap[pos] = i;
+    jobinfo[i].heapidx = pos;
+}
+
+/* dlheap_remove - Take jobs[i] out of the heap and rearm the timer */
+void dlheap_remove(int i)
+{
+    int pos = jobinfo[i].heapidx;
+
+    jobinfo[i].heapidx = -1;
+    if (pos < --dlheap_len) {
+        dlheap[pos] = dlheap[dlheap_len];
+        dlheap_sift(pos);
+    }
+    armtimer();
+}
+
+/* armtimer - Point timerfd at the earliest deadline, or disarm it */
+void armtimer(void)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (dlheap_len > 0) {
+        its.it_value.tv_sec = jobinfo[dlheap[0]].deadline / 1000000000LL;
+        its.it_value.tv_nsec = jobinfo[dlheap[0]].deadline % 1000000000LL;
+    }
+    timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+/***********************************
+ * end job deadline helper routines
+ ***********************************/
+
+
 /***********************
  * Other helper routines
  ***********************/
 
+/*
+ * readcmd - Read the next command line, newline included, into cmdline
+ *    (MAXLINE bytes). Like fgets, but reading fd 0 into our own inbuf
+ *    rather than stdio's, so that waitinput can tell whether a line is
+ *    already waiting and children have no stdin buffer of ours to seek
+ *    back on exit. Returns 0 at end of file.
+ */
+int readcmd(char *cmdline)
+{
+    char *nl;
+    int n, len;
+
+    while ((nl = memchr(inbuf, '\n', inlen)) == NULL && inlen < MAXLINE - 1) {
+        if ((n = read(STDIN_FILENO, inbuf + inlen, MAXLINE - 1 - inlen)) < 0) {
+            if (errno == EINTR)
+                continue;
+            unix_error("read error");
+        }
+        if (n == 0) /* like fgets + feof, an unterminated last line is dropped */
+            return 0;
+        inlen += n;
+    }
+
+    len = nl != NULL ? nl - inbuf + 1 : inlen; /* overlong lines are split, as fgets does */
+    memcpy(cmdline, inbuf, len);
+    cmdline[len] = '\0';
+    memmove(inbuf, inbuf + len, inlen - len);
+    inlen -= len;
+    return 1;
+}
+
+/* stdinbuffered - Return true if readcmd has a whole line waiting in inbuf */
+int stdinbuffered(void)
+{
+    return memchr(inbuf, '\n', inlen) != NULL;
+}
+
 /*
  * usage - print a help message
  */
 void usage(void)
 {
-    printf("Usage: shell [-hvp]\n");
+    printf("Usage: shell [-hvpo] [-z n]\n");
     printf("   -h   print this message\n");
     printf("   -v   print additional diagnostic information\n");
     printf("   -p   do not emit a command prompt\n");
+    printf("   -o   capture background job output (see jobs -o %%jobid)\n");
+    printf("   -z n keep n (at most %d) pre-forked children to launch commands from\n", MAXZYGOTES);
     exit(1);
 }
 